@@ -0,0 +1,131 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+
+#include "physics.h"
+
+/* number of independent matches simulated per batch */
+#define MATCH_COUNT 4096
+/* number of steps per match */
+#define STEP_COUNT 2000
+
+static double now(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static uint32_t rng = 0x12345678u;
+
+static int8_t randomMove(void) {
+    rng = rng * 1664525u + 1013904223u;
+    return (int8_t)((rng >> 24) % 3) - 1;
+}
+
+/* idle run for comparing gameplay of the two paths */
+#define IDLE_SECONDS 300
+/* largest accepted distance between the float and fixed-point positions */
+#define IDLE_TOLERANCE 0.01f
+
+/*
+ * Taps both paddles down, lets go and plays an idle match, returns the
+ * largest distance between the float and fixed-point paddles and ball.
+ */
+static float compareIdle(void) {
+    PhysicsState_t state, resolved;
+    FixPhysicsState_t fixState;
+
+    initPhysics(&state);
+    initPhysicsFix(&fixState);
+
+    float maxError = 0.0f;
+    for (int step = 0; step < IDLE_SECONDS * FIX_PHYSICS_HZ; step++) {
+        const PhysicsInput_t input = step < 6 ? (PhysicsInput_t){-1, -1} : (PhysicsInput_t){0, 0};
+
+        simulatePhysics(&state, input, 1.0f / FIX_PHYSICS_HZ);
+        simulatePhysicsFix(&fixState, input, FIX_PHYSICS_DELTA);
+        resolvePhysicsFix(&fixState, &resolved);
+
+        const float errors[] = {
+            fabsf(state.player1.offset[1] - resolved.player1.offset[1]),
+            fabsf(state.player2.offset[1] - resolved.player2.offset[1]),
+            fabsf(state.ball.offset[0] - resolved.ball.offset[0]),
+            fabsf(state.ball.offset[1] - resolved.ball.offset[1]),
+        };
+        for (size_t i = 0; i < sizeof(errors) / sizeof(errors[0]); i++) {
+            if (errors[i] > maxError)
+                maxError = errors[i];
+        }
+    }
+
+    return maxError;
+}
+
+/* FNV-1a over the fixed-point states, identical on every host if the math is bit-exact */
+static uint32_t hashStates(const FixPhysicsState_t* states, size_t count) {
+    const uint8_t* bytes = (const uint8_t*)states;
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < count * sizeof(FixPhysicsState_t); i++) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+int main(int argc, char** argv) {
+    (void) argc;
+    (void) argv;
+
+    PhysicsState_t* states = calloc(MATCH_COUNT, sizeof(PhysicsState_t));
+    FixPhysicsState_t* fixStates = calloc(MATCH_COUNT, sizeof(FixPhysicsState_t));
+    PhysicsInput_t* inputs = calloc((size_t)MATCH_COUNT * STEP_COUNT, sizeof(PhysicsInput_t));
+    if (!states || !fixStates || !inputs) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    for (size_t i = 0; i < MATCH_COUNT; i++) {
+        initPhysics(&states[i]);
+        initPhysicsFix(&fixStates[i]);
+    }
+    for (size_t i = 0; i < (size_t)MATCH_COUNT * STEP_COUNT; i++) {
+        inputs[i] = (PhysicsInput_t){randomMove(), randomMove()};
+    }
+
+    const float delta = 1.0f / FIX_PHYSICS_HZ;
+
+    double start = now();
+    for (size_t step = 0; step < STEP_COUNT; step++) {
+        simulatePhysicsBatch(states, &inputs[step * MATCH_COUNT], MATCH_COUNT, delta);
+    }
+    const double floatTime = now() - start;
+
+    start = now();
+    for (size_t step = 0; step < STEP_COUNT; step++) {
+        simulatePhysicsFixBatch(fixStates, &inputs[step * MATCH_COUNT], MATCH_COUNT, FIX_PHYSICS_DELTA);
+    }
+    const double fixTime = now() - start;
+
+    const double steps = (double)MATCH_COUNT * STEP_COUNT;
+    printf("float: %8.2f ns/step %10.2f Msteps/s\n", floatTime * 1e9 / steps, steps / floatTime * 1e-6);
+    printf("fixed: %8.2f ns/step %10.2f Msteps/s\n", fixTime * 1e9 / steps, steps / fixTime * 1e-6);
+    printf("fixed state hash: %08x\n", hashStates(fixStates, MATCH_COUNT));
+
+    // keep the float results observable
+    float sum = 0.0f;
+    for (size_t i = 0; i < MATCH_COUNT; i++) {
+        sum += states[i].ball.offset[0];
+    }
+    printf("float state sum: %f\n", sum);
+
+    const float idleError = compareIdle();
+    printf("idle %ds max float/fixed distance: %f (tolerance %f)\n", IDLE_SECONDS, idleError, IDLE_TOLERANCE);
+
+    free(inputs);
+    free(fixStates);
+    free(states);
+
+    return idleError > IDLE_TOLERANCE;
+}
@@ -0,0 +1,226 @@
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE 1
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+
+#include <arpa/inet.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+
+#include "physics.h"
+#include "spectator.h"
+
+/* largest accepted distance from the simulation, a few quantization steps */
+#define INTERPOLATION_TOLERANCE 1e-4f
+
+/* percent of packets and acks lost by a quarter of the viewers */
+#define LOSSY_PERCENT 20
+
+/* another quarter stops polling for SKIP_TICKS out of every SKIP_PERIOD, longer than the history */
+#define SKIP_TICKS 100
+#define SKIP_PERIOD 400
+
+static double threadTime(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static uint32_t rng = 0x12345678u;
+
+static int8_t randomMove(void) {
+    rng = rng * 1664525u + 1013904223u;
+    return (int8_t)((rng >> 24) % 3) - 1;
+}
+
+int main(int argc, char** argv) {
+    const int viewerCount = argc > 1 ? atoi(argv[1]) : 2000;
+    const int tickCount = argc > 2 ? atoi(argv[2]) : 1200;
+
+    // one socket per viewer
+    struct rlimit limit;
+    getrlimit(RLIMIT_NOFILE, &limit);
+    limit.rlim_cur = limit.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &limit);
+
+    SpectatorServer_t server;
+    if (spectatorServerOpen(&server, 0)) {
+        fprintf(stderr, "failed to open server\n");
+        return 1;
+    }
+
+    SpectatorClient_t* clients = calloc((size_t)viewerCount, sizeof(SpectatorClient_t));
+    if (!clients) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    for (int i = 0; i < viewerCount; i++) {
+        if (spectatorClientOpen(&clients[i], "127.0.0.1", server.port)) {
+            fprintf(stderr, "failed to open client %d\n", i);
+            return 1;
+        }
+
+        if (i % 4 == 1) {
+            clients[i].simulatedLoss = LOSSY_PERCENT;
+            clients[i].lossRandom = (uint32_t)i;
+        }
+    }
+
+    PhysicsState_t state;
+    initPhysics(&state);
+
+    PhysicsState_t view;
+    initPhysics(&view);
+
+    // simulated state of every tick in the history, the reference for interpolation
+    static PhysicsState_t simulated[SPECTATOR_HISTORY];
+
+    const float delta = 1.0f / 120.0f;
+
+    double sendTime = 0.0;
+    uint64_t mismatches = 0;
+    float maxError = 0.0f;
+    int blended = 0, resets = 0;
+
+    for (int tick = 0; tick < tickCount; tick++) {
+        simulatePhysics(&state, (PhysicsInput_t){randomMove(), randomMove()}, delta);
+
+        const double start = threadTime();
+        spectatorServerBroadcast(&server, &state);
+        sendTime += threadTime() - start;
+
+        simulated[server.tick % SPECTATOR_HISTORY] = state;
+
+        for (int i = 0; i < viewerCount; i++) {
+            // skips are staggered so the stalled viewers ack many different ticks
+            if (i % 4 == 3 && (tick + i * 7) % SKIP_PERIOD < SKIP_TICKS)
+                continue;
+
+            spectatorClientPoll(&clients[i]);
+        }
+
+        // every viewer must rebuild exactly the snapshots the server quantized, late and lossy ones too
+        for (int i = 0; i < viewerCount; i++) {
+            for (int s = 0; s < SPECTATOR_HISTORY; s++) {
+                const Snapshot_t* sent = &server.history[s];
+                const Snapshot_t* received = &clients[i].history[s];
+                for (int f = 0; f < SNAPSHOT_FIELD_COUNT; f++) {
+                    mismatches += received->tick && received->tick == sent->tick && received->fields[f] != sent->fields[f];
+                }
+            }
+        }
+
+        // sample between the two previous ticks, it should blend the simulation up to quantization
+        const uint32_t latest = clients[0].latestTick;
+        if (latest == server.tick && latest > 2 && clients[0].history[(latest - 2) % SPECTATOR_HISTORY].tick == latest - 2) {
+            const float alpha = 0.25f * (float)(1 + tick % 3);
+            const PhysicsState_t* from = &simulated[(latest - 2) % SPECTATOR_HISTORY];
+            const PhysicsState_t* to = &simulated[(latest - 1) % SPECTATOR_HISTORY];
+
+            float expected[4];
+            if (fabsf(to->ball.offset[0] - from->ball.offset[0]) > 0.5f) {
+                // a point was scored, the ball snaps to the nearest tick instead of sweeping
+                const PhysicsState_t* nearest = alpha < 0.5f ? from : to;
+                expected[0] = nearest->ball.offset[0];
+                expected[1] = nearest->ball.offset[1];
+                expected[2] = nearest->player1.offset[1];
+                expected[3] = nearest->player2.offset[1];
+                resets++;
+            } else {
+                expected[0] = from->ball.offset[0] + (to->ball.offset[0] - from->ball.offset[0]) * alpha;
+                expected[1] = from->ball.offset[1] + (to->ball.offset[1] - from->ball.offset[1]) * alpha;
+                expected[2] = from->player1.offset[1] + (to->player1.offset[1] - from->player1.offset[1]) * alpha;
+                expected[3] = from->player2.offset[1] + (to->player2.offset[1] - from->player2.offset[1]) * alpha;
+                blended++;
+            }
+
+            if (spectatorClientInterpolate(&clients[0], (float)(latest - 2) + alpha, &view)) {
+                const float errors[] = {
+                    fabsf(view.ball.offset[0] - expected[0]),
+                    fabsf(view.ball.offset[1] - expected[1]),
+                    fabsf(view.player1.offset[1] - expected[2]),
+                    fabsf(view.player2.offset[1] - expected[3]),
+                };
+                for (int e = 0; e < 4; e++) {
+                    if (errors[e] > maxError)
+                        maxError = errors[e];
+                }
+            } else {
+                maxError = INFINITY;
+            }
+        }
+    }
+
+    uint64_t received = 0, receivedBytes = 0;
+    for (int i = 0; i < viewerCount; i++) {
+        received += clients[i].packetsReceived;
+        receivedBytes += clients[i].bytesReceived;
+    }
+
+    Snapshot_t full;
+    uint8_t packet[SPECTATOR_MAX_PACKET];
+    quantizeSnapshot(&state, server.tick, &full);
+
+    const double sends = (double)viewerCount * tickCount;
+    printf("viewers: %d, ticks: %d, joined: %zu\n", viewerCount, tickCount, server.viewerCount);
+    printf("payload:     %6.2f bytes/tick/viewer (full snapshot %zu bytes, +28 bytes IPv4/UDP header)\n",
+           (double)server.bytesSent / (double)server.packetsSent, encodeSnapshot(&full, 0, packet));
+    printf("encoded:     %6.2f packets/tick, %llu full for stale acks, %llu full past %d baselines\n",
+           (double)server.packetsEncoded / tickCount, (unsigned long long)server.staleAcks,
+           (unsigned long long)server.baselineOverflows, SPECTATOR_MAX_BASELINES);
+    printf("sender cpu:  %8.1f us/tick, %6.1f ns/viewer/tick\n", sendTime * 1e6 / tickCount, sendTime * 1e9 / sends);
+    printf("delivered:   %6.2f%% (%llu dropped on send)\n", 100.0 * (double)received / sends,
+           (unsigned long long)server.packetsDropped);
+    printf("client bytes:%6.2f bytes/tick/viewer\n", (double)receivedBytes / sends);
+    printf("mismatches:  %llu\n", (unsigned long long)mismatches);
+    printf("interpolate: %d blended, %d across a point reset, max error %g (tolerance %g)\n",
+           blended, resets, maxError, INTERPOLATION_TOLERANCE);
+
+    // a snapshot a whole history behind lands in the slot of the newest one, the client has to ignore it
+    const uint32_t latest = clients[0].latestTick;
+    Snapshot_t late = server.history[(latest - 1) % SPECTATOR_HISTORY];
+    late.tick = latest - SPECTATOR_HISTORY;
+
+    struct sockaddr_in clientAddr;
+    socklen_t clientAddrLen = sizeof(clientAddr);
+    getsockname(clients[0].socket, (struct sockaddr*)&clientAddr, &clientAddrLen);
+    clientAddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    const size_t lateLen = encodeSnapshot(&late, 0, packet);
+    sendto(server.socket, packet, lateLen, 0, (struct sockaddr*)&clientAddr, sizeof(clientAddr));
+    spectatorClientPoll(&clients[0]);
+
+    const int fallbacks = server.staleAcks && server.baselineOverflows;
+    const int lateIgnored = clients[0].packetsLate == 1 && clients[0].history[latest % SPECTATOR_HISTORY].tick == latest;
+    printf("late packet: %s\n", lateIgnored ? "ignored" : "stored");
+
+    // the first half leaves, the second half goes silent and has to time out
+    for (int i = 0; i < viewerCount / 2; i++) {
+        spectatorClientClose(&clients[i]);
+    }
+    spectatorServerBroadcast(&server, &state);
+    const size_t afterLeave = server.viewerCount;
+
+    for (int tick = 0; tick <= SPECTATOR_VIEWER_TIMEOUT; tick++) {
+        spectatorServerBroadcast(&server, &state);
+    }
+    const size_t afterTimeout = server.viewerCount;
+
+    printf("eviction:    %zu viewers after %d left, %zu after %d silent ticks\n",
+           afterLeave, viewerCount / 2, afterTimeout, SPECTATOR_VIEWER_TIMEOUT);
+
+    for (int i = viewerCount / 2; i < viewerCount; i++) {
+        spectatorClientClose(&clients[i]);
+    }
+    free(clients);
+    spectatorServerClose(&server);
+
+    return mismatches != 0 || !fallbacks || !lateIgnored || maxError > INTERPOLATION_TOLERANCE || !blended || !resets || afterLeave != (size_t)(viewerCount - viewerCount / 2) || afterTimeout != 0;
+}
@@ -0,0 +1,112 @@
+
+/*
+BSD 3-Clause License
+
+Copyright (c) 2022, alinivar
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its
+   contributors may be used to endorse or promote products derived from
+   this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef __fixed_h__
+#define __fixed_h__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/*! @brief Q16.16 fixed-point number.
+ *
+ *  Signed fixed-point number with 16 integer bits and 16 fractional bits.
+ *  All operations are integer only, so results are bit-exact across
+ *  compilers, flags and architectures.
+ */
+typedef int32_t fixed;
+
+/*! @brief Number of fractional bits of a fixed-point number. */
+#define FIX_SHIFT 16
+
+/*! @brief The fixed-point representation of 1. */
+#define FIX_ONE ((fixed)1 << FIX_SHIFT)
+
+/*! @brief Convert a constant into a fixed-point number.
+ *
+ *  This macro converts a compile-time constant into a fixed-point number,
+ *  rounding to the nearest representable value. The conversion is folded
+ *  by the compiler, so it does not depend on runtime float behaviour.
+ */
+#define FIX(x) ((fixed)((x) * 65536.0 + ((x) >= 0 ? 0.5 : -0.5)))
+
+/*! @brief Convert a fixed-point number into a float.
+ *
+ *  This function converts a fixed-point number into a float.
+ *
+ *  @param[in] v The fixed-point value.
+ *  @return The float value.
+ */
+static inline float FixToFloat(fixed v) {
+    return (float)v / (float)FIX_ONE;
+}
+
+/*! @brief Multiply two fixed-point numbers.
+ *
+ *  This function multiplies two fixed-point numbers, rounding to the
+ *  nearest value. Truncating would round small negative products down
+ *  to -1 while small positive ones become 0, so damped values drift.
+ *  The physics uses FixMulFrac(), this is the reference it matches.
+ *
+ *  @param[in] first The first value.
+ *  @param[in] second The second value.
+ *  @return The result of the multiplication.
+ */
+static inline fixed FixMul(fixed first, fixed second) {
+    return (fixed)(((int64_t)first * (int64_t)second + (1 << (FIX_SHIFT - 1))) >> FIX_SHIFT);
+}
+
+/*! @brief Multiply a fixed-point number with a fraction.
+ *
+ *  This function multiplies a fixed-point number with a fraction in [0, 1),
+ *  rounding to the nearest value. The result equals FixMul(), but only
+ *  32 bit multiplies are used, so loops over it vectorize on any SIMD set.
+ *
+ *  @param[in] v The value.
+ *  @param[in] frac The fraction, must be in [0, FIX_ONE).
+ *  @return The result of the multiplication.
+ */
+static inline fixed FixMulFrac(fixed v, fixed frac) {
+    // v = hi * FIX_ONE + lo with lo in [0, FIX_ONE), lo * frac + half fits in 32 unsigned bits
+    const int32_t hi = v >> FIX_SHIFT;
+    const uint32_t lo = (uint32_t)v & (FIX_ONE - 1);
+    return hi * frac + (fixed)((lo * (uint32_t)frac + (1u << (FIX_SHIFT - 1))) >> FIX_SHIFT);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -10,41 +10,129 @@
 #include <GLFW/glfw3.h>
 
 #include "lmath.h"
+#include "physics.h"
 
 typedef struct Vertex_s {
     float position[3];
 } Vertex_t;
 
-typedef struct Rect_s {
-    float offset[2];
-    float extent[2];
-} Rect_t;
-
 static mat4 transform = {0};
 
 static unsigned int vao, vbo, ebo;
 static unsigned int vsh, fsh, pipeline;
 
-/* player movement stuff */
-static const float playerMoveSpeed = 50.0f;
+/* game state */
+static PhysicsInput_t input;
+static PhysicsState_t state;
+
+#ifdef PONG_FIXED_PHYSICS
+static FixPhysicsState_t fixState;
+#endif
+
+/* dynamic resolution stuff */
+#define TIMER_QUERY_COUNT 4
+
+static const float targetFrameTime = 1.0f / 60.0f;
+
+/* scale down above the high mark, scale up below the low mark */
+static const float frameTimeHighMark = 0.90f;
+static const float frameTimeLowMark = 0.65f;
+
+static const float minRenderScale = 0.5f;
+static const float maxRenderScale = 1.0f;
+static const float renderScaleStep = 0.0625f;
+
+/* frames a condition must hold before the scale changes, and after a change */
+static const int renderScaleHoldFrames = 30;
 
-static float player1Dp, player1DDp;
-static float player2Dp, player2DDp;
+static unsigned int fbo, colorTarget;
+static unsigned int timerQueries[TIMER_QUERY_COUNT];
+static unsigned int timerFrame;
 
-/* ball movement stuff */
-static float ballDX = -0.7f, ballDY = 0.0f;
+static int windowWidth, windowHeight;
+static int renderWidth, renderHeight;
 
-/* rectangles */
-static Rect_t player1 = {{-0.95f, 0.0f}, {0.04f, 0.65f}};
-static Rect_t player2 = {{ 0.95f, 0.0f}, {0.04f, 0.65f}};
+static float renderScale = 1.0f;
+static float gpuFrameTime;
+static int renderScaleFrames;
 
-static Rect_t ball = {{0.0f, 0.0f}, {0.02f, 0.04f}};
+static void updateRenderExtent(void) {
+    renderWidth = (int)(windowWidth * renderScale);
+    renderHeight = (int)(windowHeight * renderScale);
+
+    if (renderWidth < 1) renderWidth = 1;
+    if (renderHeight < 1) renderHeight = 1;
+
+    glViewport(0, 0, renderWidth, renderHeight);
+
+    // clear one texel past the rendered area, so the linear blit never filters in stale texels
+    glScissor(0, 0,
+              renderWidth < windowWidth ? renderWidth + 1 : renderWidth,
+              renderHeight < windowHeight ? renderHeight + 1 : renderHeight);
+}
 
 static void resizeViewport(GLFWwindow* win, int width, int height) {
     (void) win;
 
-    glViewport(0, 0, width, height);
-    glScissor(0, 0, width, height);
+    // minimized, keep the old render target
+    if (width <= 0 || height <= 0)
+        return;
+
+    // framebuffer pixels, not screen coordinates, they differ on scaled displays
+    windowWidth = width;
+    windowHeight = height;
+
+    // the target is allocated at full window resolution, lower scales only render into a corner of it
+    glDeleteTextures(1, &colorTarget);
+    glCreateTextures(GL_TEXTURE_2D, 1, &colorTarget);
+    glTextureStorage2D(colorTarget, 1, GL_RGBA8, width, height);
+
+    glNamedFramebufferTexture(fbo, GL_COLOR_ATTACHMENT0, colorTarget, 0);
+    assert(glCheckNamedFramebufferStatus(fbo, GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+
+    updateRenderExtent();
+}
+
+static void updateRenderScale(void) {
+    // read the query this frame reuses, it was issued TIMER_QUERY_COUNT frames ago so the result should not stall
+    if (timerFrame >= TIMER_QUERY_COUNT) {
+        const unsigned int query = timerQueries[timerFrame % TIMER_QUERY_COUNT];
+
+        int available = 0;
+        glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+            return;
+
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+
+        // smooth out single frame spikes
+        gpuFrameTime += ((float)elapsed * 1e-9f - gpuFrameTime) * 0.1f;
+    }
+
+    float scale = renderScale;
+
+    if (gpuFrameTime > targetFrameTime * frameTimeHighMark && renderScale > minRenderScale) {
+        renderScaleFrames = renderScaleFrames > 0 ? 0 : renderScaleFrames - 1;
+        if (-renderScaleFrames >= renderScaleHoldFrames)
+            scale = renderScale - renderScaleStep;
+    } else if (gpuFrameTime < targetFrameTime * frameTimeLowMark && renderScale < maxRenderScale) {
+        renderScaleFrames = renderScaleFrames < 0 ? 0 : renderScaleFrames + 1;
+        if (renderScaleFrames >= renderScaleHoldFrames)
+            scale = renderScale + renderScaleStep;
+    } else {
+        renderScaleFrames = 0;
+    }
+
+    if (scale != renderScale) {
+        if (scale < minRenderScale) scale = minRenderScale;
+        if (scale > maxRenderScale) scale = maxRenderScale;
+
+        renderScale = scale;
+        renderScaleFrames = 0;
+
+        updateRenderExtent();
+    }
 }
 
 static char* loadASCIIFile(const char* path, size_t* outSize) {
@@ -78,104 +166,21 @@ static void processInput(GLFWwindow* win) {
     }
 
     // player 1 input
-    player1DDp = 0.0f;
+    input.player1Move = 0;
     if (glfwGetKey(win, GLFW_KEY_W) == GLFW_PRESS) {
-        player1DDp += playerMoveSpeed;
+        input.player1Move += 1;
     }
     if (glfwGetKey(win, GLFW_KEY_S) == GLFW_PRESS) {
-        player1DDp -= playerMoveSpeed;
+        input.player1Move -= 1;
     }
     
     // player 2 input
-    player2DDp = 0.0f;
+    input.player2Move = 0;
     if (glfwGetKey(win, GLFW_KEY_UP) == GLFW_PRESS) {
-        player2DDp += playerMoveSpeed;
+        input.player2Move += 1;
     }
     if (glfwGetKey(win, GLFW_KEY_DOWN) == GLFW_PRESS) {
-        player2DDp -= playerMoveSpeed;
-    }
-}
-
-static void simulatePhysics(float delta) {
-    // player 1 physics
-    player1DDp -= player1Dp * 10.0f;
-
-    player1.offset[1] = player1.offset[1] + player1Dp * delta + player1DDp * delta * delta * 0.5f;
-    player1Dp = player1Dp + player1DDp * delta;
-    
-    // player 2 physics
-    player2DDp -= player2Dp * 5.0f;
-
-    player2.offset[1] = player2.offset[1] + player2Dp * delta + player2DDp * delta * delta * 0.5f;
-    player2Dp = player2Dp + player2DDp * delta;
-
-    // ball physics
-    ball.offset[0] += ballDX * delta;
-    ball.offset[1] += ballDY * delta;
-
-    // player1 && ball collision
-    if (ball.offset[0] + (ball.extent[0] / 2.0f) < player1.offset[0] + (player1.extent[0] / 2.0f) &&
-        ball.offset[0] - (ball.extent[0] / 2.0f) > player1.offset[0] - (player1.extent[0] / 2.0f) &&
-        ball.offset[1] + (ball.extent[1] / 2.0f) < player1.offset[1] + (player1.extent[1] / 2.0f) &&
-        ball.offset[1] + (ball.extent[1] / 2.0f) > player1.offset[1] - (player1.extent[1] / 2.0f)) {
-        ball.offset[0] = player1.offset[0] + (player1.extent[0] / 2.0f);
-        ballDX *= -1.01f;
-        ballDY = (ball.offset[1] - player1.offset[1]) * 2.0f + player1Dp * 0.75f;
-    }
-
-    // player2 && ball collision
-    if (ball.offset[0] + (ball.extent[0] / 2.0f) < player2.offset[0] + (player2.extent[0] / 2.0f) &&
-        ball.offset[0] - (ball.extent[0] / 2.0f) > player2.offset[0] - (player2.extent[0] / 2.0f) &&
-        ball.offset[1] + (ball.extent[1] / 2.0f) < player2.offset[1] + (player2.extent[1] / 2.0f) &&
-        ball.offset[1] + (ball.extent[1] / 2.0f) > player2.offset[1] - (player2.extent[1] / 2.0f)) {
-        ball.offset[0] = player2.offset[0] - (player2.extent[0] / 2.0f);
-        ballDX *= -1.01f;
-        ballDY = (ball.offset[1] - player2.offset[1]) * 2.0f + player2Dp * 0.75f;
-    }
-
-    // ball && arena collision
-    if (ball.offset[1] + (ball.extent[1] / 2.0f) > 1.0f) {
-        ball.offset[1] = 1.0f - (ball.extent[1] / 2.0f);
-        ballDY *= -1.0f;
-    }
-    if (ball.offset[1] - (ball.extent[1] / 2.0f) < -1.0f) {
-        ball.offset[1] = -1.0f + (ball.extent[1] / 2.0f);
-        ballDY *= -1.0f;
-    }
-
-    // lose condition
-
-    // player1 lose
-    if (ball.offset[0] - (ball.extent[0] / 2.0f) < -1.0f) {
-        ball = (Rect_t){{0.0f, 0.0f}, {0.02f, 0.04f}};
-        ballDX = -1.0f;
-        ballDY = 0.0f;
-    }
-    // player2 lose
-    if (ball.offset[0] + (ball.extent[0] / 2.0f) > 1.0f) {
-        ball = (Rect_t){{0.0f, 0.0f}, {0.02f, 0.04f}};
-        ballDX = -1.0f;
-        ballDY = 0.0f;
-    }
-
-    // player1 && arena collision
-    if (player1.offset[1] + (player1.extent[1] / 2.0f) > 1.0f) {
-        player1.offset[1] = 1.0f - (player1.extent[1] / 2.0f);
-        player1Dp = 0;
-    }
-    if (player1.offset[1] - (player1.extent[1] / 2.0f) < -1.0f) {
-        player1.offset[1] = -1.0f + (player1.extent[1] / 2.0f);
-        player1Dp = 0;
-    }
-
-    // player2 && arena collision
-    if (player2.offset[1] + (player2.extent[1] / 2.0f) > 1.0f) {
-        player2.offset[1] = 1.0f - (player2.extent[1] / 2.0f);
-        player2Dp = 0;
-    }
-    if (player2.offset[1] - (player2.extent[1] / 2.0f) < -1.0f) {
-        player2.offset[1] = -1.0f + (player2.extent[1] / 2.0f);
-        player2Dp = 0;
+        input.player2Move -= 1;
     }
 }
 
@@ -219,7 +224,7 @@ int main(int argc, char** argv) {
 
     assert(gladLoadGLLoader((GLADloadproc)glfwGetProcAddress) == true);
 
-    glfwSetWindowSizeCallback(win, resizeViewport);
+    glfwSetFramebufferSizeCallback(win, resizeViewport);
 
     const Vertex_t vertices[] = {
         {{-0.5f, -0.5f, 0.0f}},
@@ -262,12 +267,21 @@ int main(int argc, char** argv) {
     free((void*)fshSource);
     free((void*)vshSource);
     
+    glCreateFramebuffers(1, &fbo);
+    glCreateQueries(GL_TIME_ELAPSED, TIMER_QUERY_COUNT, timerQueries);
+
     {
-        int windowWidth, windowHeight;
-        glfwGetWindowSize(win, &windowWidth, &windowHeight);
-        resizeViewport(win, windowWidth, windowHeight);
+        int width, height;
+        glfwGetFramebufferSize(win, &width, &height);
+        resizeViewport(win, width, height);
     }
 
+    initPhysics(&state);
+#ifdef PONG_FIXED_PHYSICS
+    initPhysicsFix(&fixState);
+    float accumulator = 0.0f;
+#endif
+
     glfwShowWindow(win);
 
     float current = 0.0f, last = 0.0f, delta;
@@ -276,19 +290,53 @@ int main(int argc, char** argv) {
         delta = current - last;
         last = current;
 
+        updateRenderScale();
+        glBeginQuery(GL_TIME_ELAPSED, timerQueries[timerFrame % TIMER_QUERY_COUNT]);
+
+        // only clear and draw the scaled part of the target
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo);
+        glEnable(GL_SCISSOR_TEST);
         glClearBufferfv(GL_COLOR, 0, (float[]){0.1f, 0.1f, 0.1f, 1.0f});
 
         processInput(win);
-        simulatePhysics(delta);
+#ifdef PONG_FIXED_PHYSICS
+        // cap the backlog, a long frame would otherwise take even longer to catch up
+        accumulator += delta;
+        if (accumulator > (float)FIX_PHYSICS_MAX_STEPS / FIX_PHYSICS_HZ)
+            accumulator = (float)FIX_PHYSICS_MAX_STEPS / FIX_PHYSICS_HZ;
+
+        // fixed timestep, so the simulation only depends on the input per step
+        for (; accumulator >= 1.0f / FIX_PHYSICS_HZ; accumulator -= 1.0f / FIX_PHYSICS_HZ) {
+            simulatePhysicsFix(&fixState, input, FIX_PHYSICS_DELTA);
+        }
+        resolvePhysicsFix(&fixState, &state);
+#else
+        simulatePhysics(&state, input, delta);
+#endif
 
-        drawRect(ball);
-        drawRect(player1);
-        drawRect(player2);
+        drawRect(state.ball);
+        drawRect(state.player1);
+        drawRect(state.player2);
+
+        // upscale to the window
+        glDisable(GL_SCISSOR_TEST);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+        glBlitNamedFramebuffer(fbo, 0,
+                               0, 0, renderWidth, renderHeight,
+                               0, 0, windowWidth, windowHeight,
+                               GL_COLOR_BUFFER_BIT, GL_LINEAR);
+
+        glEndQuery(GL_TIME_ELAPSED);
+        timerFrame++;
 
         glfwSwapBuffers(win);
         glfwPollEvents();
     }
 
+    glDeleteQueries(TIMER_QUERY_COUNT, timerQueries);
+    glDeleteFramebuffers(1, &fbo);
+    glDeleteTextures(1, &colorTarget);
+
     glDeleteProgramPipelines(1, &pipeline);
     glDeleteProgram(fsh);
     glDeleteProgram(vsh);
@@ -0,0 +1,258 @@
+
+#include "physics.h"
+
+/* player movement stuff */
+static const float playerMoveSpeed = 50.0f;
+
+static const Rect_t ballStart = {{0.0f, 0.0f}, {0.02f, 0.04f}};
+
+void initPhysics(PhysicsState_t* state) {
+    *state = (PhysicsState_t){
+        .player1 = {{-0.95f, 0.0f}, {0.04f, 0.65f}},
+        .player2 = {{ 0.95f, 0.0f}, {0.04f, 0.65f}},
+        .ball = ballStart,
+        .ballDX = -0.7f,
+        .ballDY = 0.0f,
+    };
+}
+
+static inline void stepPhysics(PhysicsState_t* s, PhysicsInput_t input, float delta) {
+    float player1DDp = playerMoveSpeed * input.player1Move;
+    float player2DDp = playerMoveSpeed * input.player2Move;
+
+    // player 1 physics
+    player1DDp -= s->player1Dp * 10.0f;
+
+    s->player1.offset[1] = s->player1.offset[1] + s->player1Dp * delta + player1DDp * delta * delta * 0.5f;
+    s->player1Dp = s->player1Dp + player1DDp * delta;
+
+    // player 2 physics
+    player2DDp -= s->player2Dp * 5.0f;
+
+    s->player2.offset[1] = s->player2.offset[1] + s->player2Dp * delta + player2DDp * delta * delta * 0.5f;
+    s->player2Dp = s->player2Dp + player2DDp * delta;
+
+    // ball physics
+    s->ball.offset[0] += s->ballDX * delta;
+    s->ball.offset[1] += s->ballDY * delta;
+
+    // player1 && ball collision
+    if (s->ball.offset[0] + (s->ball.extent[0] / 2.0f) < s->player1.offset[0] + (s->player1.extent[0] / 2.0f) &&
+        s->ball.offset[0] - (s->ball.extent[0] / 2.0f) > s->player1.offset[0] - (s->player1.extent[0] / 2.0f) &&
+        s->ball.offset[1] + (s->ball.extent[1] / 2.0f) < s->player1.offset[1] + (s->player1.extent[1] / 2.0f) &&
+        s->ball.offset[1] + (s->ball.extent[1] / 2.0f) > s->player1.offset[1] - (s->player1.extent[1] / 2.0f)) {
+        s->ball.offset[0] = s->player1.offset[0] + (s->player1.extent[0] / 2.0f);
+        s->ballDX *= -1.01f;
+        s->ballDY = (s->ball.offset[1] - s->player1.offset[1]) * 2.0f + s->player1Dp * 0.75f;
+    }
+
+    // player2 && ball collision
+    if (s->ball.offset[0] + (s->ball.extent[0] / 2.0f) < s->player2.offset[0] + (s->player2.extent[0] / 2.0f) &&
+        s->ball.offset[0] - (s->ball.extent[0] / 2.0f) > s->player2.offset[0] - (s->player2.extent[0] / 2.0f) &&
+        s->ball.offset[1] + (s->ball.extent[1] / 2.0f) < s->player2.offset[1] + (s->player2.extent[1] / 2.0f) &&
+        s->ball.offset[1] + (s->ball.extent[1] / 2.0f) > s->player2.offset[1] - (s->player2.extent[1] / 2.0f)) {
+        s->ball.offset[0] = s->player2.offset[0] - (s->player2.extent[0] / 2.0f);
+        s->ballDX *= -1.01f;
+        s->ballDY = (s->ball.offset[1] - s->player2.offset[1]) * 2.0f + s->player2Dp * 0.75f;
+    }
+
+    // ball && arena collision
+    if (s->ball.offset[1] + (s->ball.extent[1] / 2.0f) > 1.0f) {
+        s->ball.offset[1] = 1.0f - (s->ball.extent[1] / 2.0f);
+        s->ballDY *= -1.0f;
+    }
+    if (s->ball.offset[1] - (s->ball.extent[1] / 2.0f) < -1.0f) {
+        s->ball.offset[1] = -1.0f + (s->ball.extent[1] / 2.0f);
+        s->ballDY *= -1.0f;
+    }
+
+    // lose condition
+
+    // player1 lose
+    if (s->ball.offset[0] - (s->ball.extent[0] / 2.0f) < -1.0f) {
+        s->ball = ballStart;
+        s->ballDX = -1.0f;
+        s->ballDY = 0.0f;
+    }
+    // player2 lose
+    if (s->ball.offset[0] + (s->ball.extent[0] / 2.0f) > 1.0f) {
+        s->ball = ballStart;
+        s->ballDX = -1.0f;
+        s->ballDY = 0.0f;
+    }
+
+    // player1 && arena collision
+    if (s->player1.offset[1] + (s->player1.extent[1] / 2.0f) > 1.0f) {
+        s->player1.offset[1] = 1.0f - (s->player1.extent[1] / 2.0f);
+        s->player1Dp = 0;
+    }
+    if (s->player1.offset[1] - (s->player1.extent[1] / 2.0f) < -1.0f) {
+        s->player1.offset[1] = -1.0f + (s->player1.extent[1] / 2.0f);
+        s->player1Dp = 0;
+    }
+
+    // player2 && arena collision
+    if (s->player2.offset[1] + (s->player2.extent[1] / 2.0f) > 1.0f) {
+        s->player2.offset[1] = 1.0f - (s->player2.extent[1] / 2.0f);
+        s->player2Dp = 0;
+    }
+    if (s->player2.offset[1] - (s->player2.extent[1] / 2.0f) < -1.0f) {
+        s->player2.offset[1] = -1.0f + (s->player2.extent[1] / 2.0f);
+        s->player2Dp = 0;
+    }
+}
+
+void simulatePhysics(PhysicsState_t* state, PhysicsInput_t input, float delta) {
+    stepPhysics(state, input, delta);
+}
+
+void simulatePhysicsBatch(PhysicsState_t* states, const PhysicsInput_t* inputs, size_t count, float delta) {
+    for (size_t i = 0; i < count; i++) {
+        stepPhysics(&states[i], inputs[i], delta);
+    }
+}
+
+/*
+ * Fixed-point physics.
+ *
+ * Mirrors stepPhysics() operation for operation in Q16.16, so gameplay
+ * matches the float path while every result is bit-exact on any compiler
+ * and architecture. Every product has a factor in [0, 1), the step delta
+ * or a constant, so they go through FixMulFrac() and stay in 32 bits.
+ * Halving is a division, which truncates towards zero everywhere.
+ */
+
+static const fixed fixPlayerMoveSpeed = FIX(50.0);
+
+static const FixRect_t fixBallStart = {{FIX(0.0), FIX(0.0)}, {FIX(0.02), FIX(0.04)}};
+
+void initPhysicsFix(FixPhysicsState_t* state) {
+    *state = (FixPhysicsState_t){
+        .player1 = {{FIX(-0.95), FIX(0.0)}, {FIX(0.04), FIX(0.65)}},
+        .player2 = {{FIX( 0.95), FIX(0.0)}, {FIX(0.04), FIX(0.65)}},
+        .ball = fixBallStart,
+        .ballDX = FIX(-0.7),
+        .ballDY = FIX(0.0),
+    };
+}
+
+static inline void stepPhysicsFix(FixPhysicsState_t* s, PhysicsInput_t input, fixed delta) {
+    /*
+     * Same steps as stepPhysics(), but on locals with every branch written
+     * as a select and a single store at the end, so the batched loop has no
+     * control flow and can be vectorized across matches.
+     */
+    const fixed player1X = s->player1.offset[0], player1HalfW = s->player1.extent[0] / 2, player1HalfH = s->player1.extent[1] / 2;
+    const fixed player2X = s->player2.offset[0], player2HalfW = s->player2.extent[0] / 2, player2HalfH = s->player2.extent[1] / 2;
+    const fixed ballHalfW = s->ball.extent[0] / 2, ballHalfH = s->ball.extent[1] / 2;
+
+    fixed player1Y = s->player1.offset[1], player1Dp = s->player1Dp;
+    fixed player2Y = s->player2.offset[1], player2Dp = s->player2Dp;
+    fixed ballX = s->ball.offset[0], ballY = s->ball.offset[1];
+    fixed ballDX = s->ballDX, ballDY = s->ballDY;
+
+    // player 1 physics
+    const fixed player1DDp = fixPlayerMoveSpeed * input.player1Move - player1Dp * 10;
+
+    player1Y = player1Y + FixMulFrac(player1Dp, delta) + FixMulFrac(FixMulFrac(player1DDp, delta), delta) / 2;
+    player1Dp = player1Dp + FixMulFrac(player1DDp, delta);
+
+    // player 2 physics
+    const fixed player2DDp = fixPlayerMoveSpeed * input.player2Move - player2Dp * 5;
+
+    player2Y = player2Y + FixMulFrac(player2Dp, delta) + FixMulFrac(FixMulFrac(player2DDp, delta), delta) / 2;
+    player2Dp = player2Dp + FixMulFrac(player2DDp, delta);
+
+    // ball physics
+    ballX += FixMulFrac(ballDX, delta);
+    ballY += FixMulFrac(ballDY, delta);
+
+    // player1 && ball collision
+    const int hit1 = (ballX + ballHalfW < player1X + player1HalfW) &
+                     (ballX - ballHalfW > player1X - player1HalfW) &
+                     (ballY + ballHalfH < player1Y + player1HalfH) &
+                     (ballY + ballHalfH > player1Y - player1HalfH);
+    ballX  = hit1 ? player1X + player1HalfW : ballX;
+    ballDX = hit1 ? -(ballDX + FixMulFrac(ballDX, FIX(0.01))) : ballDX;
+    ballDY = hit1 ? (ballY - player1Y) * 2 + FixMulFrac(player1Dp, FIX(0.75)) : ballDY;
+
+    // player2 && ball collision
+    const int hit2 = (ballX + ballHalfW < player2X + player2HalfW) &
+                     (ballX - ballHalfW > player2X - player2HalfW) &
+                     (ballY + ballHalfH < player2Y + player2HalfH) &
+                     (ballY + ballHalfH > player2Y - player2HalfH);
+    ballX  = hit2 ? player2X - player2HalfW : ballX;
+    ballDX = hit2 ? -(ballDX + FixMulFrac(ballDX, FIX(0.01))) : ballDX;
+    ballDY = hit2 ? (ballY - player2Y) * 2 + FixMulFrac(player2Dp, FIX(0.75)) : ballDY;
+
+    // ball && arena collision
+    const int ballTop = ballY + ballHalfH > FIX_ONE;
+    ballY  = ballTop ? FIX_ONE - ballHalfH : ballY;
+    ballDY = ballTop ? -ballDY : ballDY;
+
+    const int ballBottom = ballY - ballHalfH < -FIX_ONE;
+    ballY  = ballBottom ? -FIX_ONE + ballHalfH : ballY;
+    ballDY = ballBottom ? -ballDY : ballDY;
+
+    // lose condition, player1 or player2 lose
+    const int lose = (ballX - ballHalfW < -FIX_ONE) | (ballX + ballHalfW > FIX_ONE);
+    ballX  = lose ? fixBallStart.offset[0] : ballX;
+    ballY  = lose ? fixBallStart.offset[1] : ballY;
+    ballDX = lose ? -FIX_ONE : ballDX;
+    ballDY = lose ? 0 : ballDY;
+
+    // player1 && arena collision
+    const int player1Top = player1Y + player1HalfH > FIX_ONE;
+    player1Y  = player1Top ? FIX_ONE - player1HalfH : player1Y;
+    player1Dp = player1Top ? 0 : player1Dp;
+
+    const int player1Bottom = player1Y - player1HalfH < -FIX_ONE;
+    player1Y  = player1Bottom ? -FIX_ONE + player1HalfH : player1Y;
+    player1Dp = player1Bottom ? 0 : player1Dp;
+
+    // player2 && arena collision
+    const int player2Top = player2Y + player2HalfH > FIX_ONE;
+    player2Y  = player2Top ? FIX_ONE - player2HalfH : player2Y;
+    player2Dp = player2Top ? 0 : player2Dp;
+
+    const int player2Bottom = player2Y - player2HalfH < -FIX_ONE;
+    player2Y  = player2Bottom ? -FIX_ONE + player2HalfH : player2Y;
+    player2Dp = player2Bottom ? 0 : player2Dp;
+
+    s->player1.offset[1]    = player1Y;
+    s->player2.offset[1]    = player2Y;
+    s->ball.offset[0]       = ballX;
+    s->ball.offset[1]       = ballY;
+    s->player1Dp            = player1Dp;
+    s->player2Dp            = player2Dp;
+    s->ballDX               = ballDX;
+    s->ballDY               = ballDY;
+}
+
+void simulatePhysicsFix(FixPhysicsState_t* state, PhysicsInput_t input, fixed delta) {
+    stepPhysicsFix(state, input, delta);
+}
+
+void simulatePhysicsFixBatch(FixPhysicsState_t* states, const PhysicsInput_t* inputs, size_t count, fixed delta) {
+    for (size_t i = 0; i < count; i++) {
+        stepPhysicsFix(&states[i], inputs[i], delta);
+    }
+}
+
+static inline Rect_t resolveRect(FixRect_t rect) {
+    return (Rect_t){
+        {FixToFloat(rect.offset[0]), FixToFloat(rect.offset[1])},
+        {FixToFloat(rect.extent[0]), FixToFloat(rect.extent[1])},
+    };
+}
+
+void resolvePhysicsFix(const FixPhysicsState_t* state, PhysicsState_t* out) {
+    out->player1    = resolveRect(state->player1);
+    out->player2    = resolveRect(state->player2);
+    out->ball       = resolveRect(state->ball);
+
+    out->player1Dp  = FixToFloat(state->player1Dp);
+    out->player2Dp  = FixToFloat(state->player2Dp);
+    out->ballDX     = FixToFloat(state->ballDX);
+    out->ballDY     = FixToFloat(state->ballDY);
+}
@@ -0,0 +1,60 @@
+
+#ifndef __physics_h__
+#define __physics_h__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "fixed.h"
+
+typedef struct Rect_s {
+    float offset[2];
+    float extent[2];
+} Rect_t;
+
+typedef struct FixRect_s {
+    fixed offset[2];
+    fixed extent[2];
+} FixRect_t;
+
+/* paddle input for one step, -1 (down), 0 or 1 (up) */
+typedef struct PhysicsInput_s {
+    int8_t player1Move;
+    int8_t player2Move;
+} PhysicsInput_t;
+
+typedef struct PhysicsState_s {
+    Rect_t player1, player2, ball;
+
+    float player1Dp, player2Dp;
+    float ballDX, ballDY;
+} PhysicsState_t;
+
+/* deterministic Q16.16 counterpart of PhysicsState_t */
+typedef struct FixPhysicsState_s {
+    FixRect_t player1, player2, ball;
+
+    fixed player1Dp, player2Dp;
+    fixed ballDX, ballDY;
+} FixPhysicsState_t;
+
+/* timestep of the fixed-point simulation, in seconds */
+#define FIX_PHYSICS_HZ 120
+#define FIX_PHYSICS_DELTA (FIX_ONE / FIX_PHYSICS_HZ)
+
+/* most steps run per frame, time beyond that is dropped */
+#define FIX_PHYSICS_MAX_STEPS 4
+
+void initPhysics(PhysicsState_t* state);
+void simulatePhysics(PhysicsState_t* state, PhysicsInput_t input, float delta);
+void simulatePhysicsBatch(PhysicsState_t* states, const PhysicsInput_t* inputs, size_t count, float delta);
+
+void initPhysicsFix(FixPhysicsState_t* state);
+/* delta must be below FIX_ONE, one second */
+void simulatePhysicsFix(FixPhysicsState_t* state, PhysicsInput_t input, fixed delta);
+void simulatePhysicsFixBatch(FixPhysicsState_t* states, const PhysicsInput_t* inputs, size_t count, fixed delta);
+
+/* converts the fixed-point state into floats for rendering */
+void resolvePhysicsFix(const FixPhysicsState_t* state, PhysicsState_t* out);
+
+#endif
@@ -0,0 +1,799 @@
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE 1
+#endif
+
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "spectator.h"
+
+enum {
+    PACKET_SNAPSHOT     = 1,
+    PACKET_ACK          = 2,
+    PACKET_JOIN         = 3,
+    PACKET_CHALLENGE    = 4,
+    PACKET_LEAVE        = 5,
+};
+
+/* join and challenge have the same size, so the server never answers with more than it got */
+#define HANDSHAKE_PACKET_SIZE 5
+
+/* quantization steps, positions cover [-2, 2) and velocities [-32, 32) */
+static const float fieldScales[SNAPSHOT_FIELD_COUNT] = {
+    [SNAPSHOT_BALL_X]       = 16384.0f,
+    [SNAPSHOT_BALL_Y]       = 16384.0f,
+    [SNAPSHOT_BALL_DX]      = 1024.0f,
+    [SNAPSHOT_BALL_DY]      = 1024.0f,
+    [SNAPSHOT_PLAYER1_Y]    = 16384.0f,
+    [SNAPSHOT_PLAYER2_Y]    = 16384.0f,
+};
+
+/* send buffers, shared by all servers since the game is single threaded */
+#ifdef __linux__
+static struct mmsghdr sendMsgs[SPECTATOR_SEND_BATCH];
+#else
+static struct msghdr sendMsgs[SPECTATOR_SEND_BATCH];
+#endif
+static struct iovec sendIovs[SPECTATOR_SEND_BATCH];
+
+static struct msghdr* sendHeader(int i) {
+#ifdef __linux__
+    return &sendMsgs[i].msg_hdr;
+#else
+    return &sendMsgs[i];
+#endif
+}
+
+static int16_t quantize(float v, float scale) {
+    const float q = roundf(v * scale);
+    if (q > INT16_MAX) return INT16_MAX;
+    if (q < INT16_MIN) return INT16_MIN;
+    return (int16_t)q;
+}
+
+static size_t writeVarint(uint8_t* out, uint32_t v) {
+    size_t len = 0;
+    while (v >= 0x80) {
+        out[len++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    out[len++] = (uint8_t)v;
+    return len;
+}
+
+static int readVarint(const uint8_t* packet, size_t len, size_t* pos, uint32_t* out) {
+    uint32_t v = 0;
+    for (int shift = 0; shift < 35 && *pos < len; shift += 7) {
+        const uint8_t b = packet[(*pos)++];
+        v |= (uint32_t)(b & 0x7f) << shift;
+        if (!(b & 0x80)) {
+            *out = v;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+static size_t writeU32(uint8_t* out, uint32_t v) {
+    out[0] = (uint8_t)v;
+    out[1] = (uint8_t)(v >> 8);
+    out[2] = (uint8_t)(v >> 16);
+    out[3] = (uint8_t)(v >> 24);
+    return 4;
+}
+
+static int readU32(const uint8_t* packet, size_t len, size_t* pos, uint32_t* out) {
+    if (*pos > len || len - *pos < 4)
+        return -1;
+    const uint8_t* b = &packet[*pos];
+    *out = (uint32_t)b[0] | (uint32_t)b[1] << 8 | (uint32_t)b[2] << 16 | (uint32_t)b[3] << 24;
+    *pos += 4;
+    return 0;
+}
+
+static uint32_t zigzag(int32_t v) {
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static int32_t unzigzag(uint32_t v) {
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+static const Snapshot_t* findSnapshot(const Snapshot_t* history, uint32_t tick) {
+    const Snapshot_t* snap = &history[tick % SPECTATOR_HISTORY];
+    return tick != 0 && snap->tick == tick ? snap : 0;
+}
+
+void quantizeSnapshot(const PhysicsState_t* state, uint32_t tick, Snapshot_t* out) {
+    out->tick = tick;
+    out->fields[SNAPSHOT_BALL_X]    = quantize(state->ball.offset[0], fieldScales[SNAPSHOT_BALL_X]);
+    out->fields[SNAPSHOT_BALL_Y]    = quantize(state->ball.offset[1], fieldScales[SNAPSHOT_BALL_Y]);
+    out->fields[SNAPSHOT_BALL_DX]   = quantize(state->ballDX, fieldScales[SNAPSHOT_BALL_DX]);
+    out->fields[SNAPSHOT_BALL_DY]   = quantize(state->ballDY, fieldScales[SNAPSHOT_BALL_DY]);
+    out->fields[SNAPSHOT_PLAYER1_Y] = quantize(state->player1.offset[1], fieldScales[SNAPSHOT_PLAYER1_Y]);
+    out->fields[SNAPSHOT_PLAYER2_Y] = quantize(state->player2.offset[1], fieldScales[SNAPSHOT_PLAYER2_Y]);
+}
+
+/*
+ * Snapshot packet:
+ *   u8     PACKET_SNAPSHOT
+ *   varint tick
+ *   varint tick - baseline tick, 0 for a full snapshot
+ *   u8     mask of fields that differ from the baseline
+ *   varint zigzag difference of every field in the mask
+ *
+ * Join handshake, the server keeps no state until the ack proves the
+ * address receives its packets, so spoofed joins can't register viewers:
+ *   client  u8 PACKET_JOIN, 4 zero bytes of padding
+ *   server  u8 PACKET_CHALLENGE, u32 cookie of the client address
+ *
+ * Ack packet, the first one registers the viewer:
+ *   u8     PACKET_ACK
+ *   u32    cookie
+ *   varint newest tick received, 0 if none yet
+ *
+ * Leave packet:
+ *   u8     PACKET_LEAVE
+ *   u32    cookie
+ */
+size_t encodeSnapshot(const Snapshot_t* snap, const Snapshot_t* baseline, uint8_t* out) {
+    static const Snapshot_t zero = {0};
+    if (!baseline)
+        baseline = &zero;
+
+    size_t len = 0;
+    out[len++] = PACKET_SNAPSHOT;
+    len += writeVarint(&out[len], snap->tick);
+    len += writeVarint(&out[len], baseline->tick ? snap->tick - baseline->tick : 0);
+
+    uint8_t* mask = &out[len++];
+    *mask = 0;
+
+    for (int i = 0; i < SNAPSHOT_FIELD_COUNT; i++) {
+        const int32_t diff = (int32_t)snap->fields[i] - (int32_t)baseline->fields[i];
+        if (diff) {
+            *mask |= (uint8_t)(1 << i);
+            len += writeVarint(&out[len], zigzag(diff));
+        }
+    }
+
+    return len;
+}
+
+int decodeSnapshot(const uint8_t* packet, size_t len, const Snapshot_t* history, Snapshot_t* out) {
+    static const Snapshot_t zero = {0};
+
+    size_t pos = 0;
+    uint32_t tick, distance, v;
+
+    if (len < 1 || packet[pos++] != PACKET_SNAPSHOT)
+        return -1;
+    if (readVarint(packet, len, &pos, &tick) || readVarint(packet, len, &pos, &distance) || pos >= len)
+        return -1;
+    if (tick == 0 || distance > tick)
+        return -1;
+
+    const Snapshot_t* baseline = distance ? findSnapshot(history, tick - distance) : &zero;
+    if (!baseline)
+        return -1;
+
+    const uint8_t mask = packet[pos++];
+
+    Snapshot_t snap = *baseline;
+    snap.tick = tick;
+    for (int i = 0; i < SNAPSHOT_FIELD_COUNT; i++) {
+        if (mask & (1 << i)) {
+            if (readVarint(packet, len, &pos, &v))
+                return -1;
+            snap.fields[i] = (int16_t)(snap.fields[i] + unzigzag(v));
+        }
+    }
+
+    *out = snap;
+    return 0;
+}
+
+static int openSocket(uint16_t port) {
+    const int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock < 0)
+        return -1;
+
+    struct sockaddr_in addr = {0};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+
+    if (bind(sock, (struct sockaddr*)&addr, sizeof(addr)) < 0 ||
+        fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK) < 0) {
+        close(sock);
+        return -1;
+    }
+
+    return sock;
+}
+
+static uint32_t hashAddr(const struct sockaddr_in* addr) {
+    const uint64_t key = ((uint64_t)addr->sin_addr.s_addr << 16) | addr->sin_port;
+    return (uint32_t)((key * 0x9e3779b97f4a7c15ull) >> 32);
+}
+
+static int readRandom(void* out, size_t len) {
+    FILE* random = fopen("/dev/urandom", "rb");
+    if (!random)
+        return -1;
+
+    const size_t read = fread(out, len, 1, random);
+    fclose(random);
+    return read == 1 ? 0 : -1;
+}
+
+static uint64_t rotl64(uint64_t v, int bits) {
+    return (v << bits) | (v >> (64 - bits));
+}
+
+#define SIPROUND(v0, v1, v2, v3) do {                                       \
+        v0 += v1; v1 = rotl64(v1, 13); v1 ^= v0; v0 = rotl64(v0, 32);      \
+        v2 += v3; v3 = rotl64(v3, 16); v3 ^= v2;                           \
+        v0 += v3; v3 = rotl64(v3, 21); v3 ^= v0;                           \
+        v2 += v1; v1 = rotl64(v1, 17); v1 ^= v2; v2 = rotl64(v2, 32);      \
+    } while (0)
+
+/* SipHash-2-4 of a message shorter than 8 bytes */
+static uint64_t sipHash(const uint64_t key[2], const uint8_t* data, size_t len) {
+    uint64_t v0 = key[0] ^ 0x736f6d6570736575ull;
+    uint64_t v1 = key[1] ^ 0x646f72616e646f6dull;
+    uint64_t v2 = key[0] ^ 0x6c7967656e657261ull;
+    uint64_t v3 = key[1] ^ 0x7465646279746573ull;
+
+    uint64_t m = (uint64_t)len << 56;
+    for (size_t i = 0; i < len; i++) {
+        m |= (uint64_t)data[i] << (8 * i);
+    }
+
+    v3 ^= m;
+    SIPROUND(v0, v1, v2, v3);
+    SIPROUND(v0, v1, v2, v3);
+    v0 ^= m;
+
+    v2 ^= 0xff;
+    SIPROUND(v0, v1, v2, v3);
+    SIPROUND(v0, v1, v2, v3);
+    SIPROUND(v0, v1, v2, v3);
+    SIPROUND(v0, v1, v2, v3);
+
+    return v0 ^ v1 ^ v2 ^ v3;
+}
+
+/* cookie of an address under cookie key 0 (current) or 1 (previous) */
+static uint32_t cookieFor(const SpectatorServer_t* server, int key, const struct sockaddr_in* addr) {
+    uint8_t data[6];
+    memcpy(&data[0], &addr->sin_addr.s_addr, 4);
+    memcpy(&data[4], &addr->sin_port, 2);
+    return (uint32_t)sipHash(server->cookieKeys[key], data, sizeof(data));
+}
+
+/* returns the key the cookie was made with, -1 if it is not valid */
+static int checkCookie(const SpectatorServer_t* server, uint32_t cookie, const struct sockaddr_in* addr) {
+    if (cookie == cookieFor(server, 0, addr))
+        return 0;
+    if (cookie == cookieFor(server, 1, addr))
+        return 1;
+    return -1;
+}
+
+static void sendChallenge(SpectatorServer_t* server, const struct sockaddr_in* addr) {
+    uint8_t challenge[HANDSHAKE_PACKET_SIZE];
+    challenge[0] = PACKET_CHALLENGE;
+    writeU32(&challenge[1], cookieFor(server, 0, addr));
+
+    sendto(server->socket, challenge, sizeof(challenge), MSG_DONTWAIT, (const struct sockaddr*)addr, sizeof(*addr));
+}
+
+static void rotateCookieKey(SpectatorServer_t* server) {
+    uint64_t key[2];
+
+    // keep the current key if there is no randomness, better than a predictable one
+    if (readRandom(key, sizeof(key)))
+        return;
+
+    server->cookieKeys[1][0] = server->cookieKeys[0][0];
+    server->cookieKeys[1][1] = server->cookieKeys[0][1];
+    server->cookieKeys[0][0] = key[0];
+    server->cookieKeys[0][1] = key[1];
+}
+
+static int sameAddr(const struct sockaddr_in* first, const struct sockaddr_in* second) {
+    return first->sin_addr.s_addr == second->sin_addr.s_addr && first->sin_port == second->sin_port;
+}
+
+static void fillViewerMap(SpectatorServer_t* server) {
+    const size_t mask = server->viewerMapCapacity - 1;
+
+    memset(server->viewerMap, 0, server->viewerMapCapacity * sizeof(uint32_t));
+    for (size_t i = 0; i < server->viewerCount; i++) {
+        size_t slot = hashAddr(&server->viewers[i].addr) & mask;
+        while (server->viewerMap[slot])
+            slot = (slot + 1) & mask;
+        server->viewerMap[slot] = (uint32_t)(i + 1);
+    }
+}
+
+static int growViewerMap(SpectatorServer_t* server) {
+    const size_t capacity = server->viewerMapCapacity ? server->viewerMapCapacity * 2 : 1024;
+
+    uint32_t* map = calloc(capacity, sizeof(uint32_t));
+    if (!map)
+        return -1;
+
+    free(server->viewerMap);
+    server->viewerMap = map;
+    server->viewerMapCapacity = capacity;
+
+    fillViewerMap(server);
+    return 0;
+}
+
+/* looks up the viewer at addr, and registers it if add is set */
+static SpectatorViewer_t* findViewer(SpectatorServer_t* server, const struct sockaddr_in* addr, int add) {
+    if (server->viewerMapCapacity < (server->viewerCount + 1) * 2 && growViewerMap(server))
+        return 0;
+
+    const size_t mask = server->viewerMapCapacity - 1;
+    size_t slot = hashAddr(addr) & mask;
+    for (; server->viewerMap[slot]; slot = (slot + 1) & mask) {
+        SpectatorViewer_t* viewer = &server->viewers[server->viewerMap[slot] - 1];
+        if (sameAddr(&viewer->addr, addr))
+            return viewer;
+    }
+
+    if (!add)
+        return 0;
+
+    // new viewer
+    if (server->viewerCount == server->viewerCapacity) {
+        const size_t capacity = server->viewerCapacity ? server->viewerCapacity * 2 : 64;
+        SpectatorViewer_t* viewers = realloc(server->viewers, capacity * sizeof(SpectatorViewer_t));
+        if (!viewers)
+            return 0;
+        server->viewers = viewers;
+        server->viewerCapacity = capacity;
+    }
+
+    SpectatorViewer_t* viewer = &server->viewers[server->viewerCount++];
+    *viewer = (SpectatorViewer_t){0};
+    viewer->addr = *addr;
+    viewer->heardTick = server->tick;
+
+    server->viewerMap[slot] = (uint32_t)server->viewerCount;
+    return viewer;
+}
+
+static void evictViewers(SpectatorServer_t* server) {
+    size_t count = server->viewerCount;
+    for (size_t i = 0; i < count;) {
+        const SpectatorViewer_t* viewer = &server->viewers[i];
+        if (viewer->left || server->tick - viewer->heardTick > SPECTATOR_VIEWER_TIMEOUT) {
+            server->viewers[i] = server->viewers[--count];
+            server->viewersEvicted++;
+        } else {
+            i++;
+        }
+    }
+
+    // swap-remove moved viewers around, refill the map instead of patching slots, it only got emptier
+    if (count != server->viewerCount) {
+        server->viewerCount = count;
+        fillViewerMap(server);
+    }
+}
+
+static void handlePacket(SpectatorServer_t* server, const uint8_t* packet, size_t len, const struct sockaddr_in* addr) {
+    size_t pos = 1;
+    uint32_t cookie, tick;
+
+    if (len < 1)
+        return;
+
+    switch (packet[0]) {
+    case PACKET_JOIN: {
+        if (len < HANDSHAKE_PACKET_SIZE)
+            return;
+
+        sendChallenge(server, addr);
+        break;
+    }
+    case PACKET_ACK: {
+        if (readU32(packet, len, &pos, &cookie) || readVarint(packet, len, &pos, &tick))
+            return;
+
+        const int key = checkCookie(server, cookie, addr);
+        if (key < 0)
+            return;
+
+        SpectatorViewer_t* viewer = findViewer(server, addr, 1);
+        if (!viewer)
+            return;
+
+        // made with the previous key, hand out a fresh cookie before that key is gone too
+        if (key == 1)
+            sendChallenge(server, addr);
+
+        viewer->heardTick = server->tick;
+        if (tick > viewer->ackTick && tick <= server->tick)
+            viewer->ackTick = tick;
+        break;
+    }
+    case PACKET_LEAVE: {
+        if (readU32(packet, len, &pos, &cookie) || checkCookie(server, cookie, addr) < 0)
+            return;
+
+        SpectatorViewer_t* viewer = findViewer(server, addr, 0);
+        if (viewer)
+            viewer->left = 1;
+        break;
+    }
+    }
+}
+
+static void drainAcks(SpectatorServer_t* server) {
+#ifdef __linux__
+    enum { ACK_BATCH = 256, ACK_MAX = 16 };
+
+    static struct mmsghdr msgs[ACK_BATCH];
+    static struct iovec iovs[ACK_BATCH];
+    static struct sockaddr_in addrs[ACK_BATCH];
+    static uint8_t bufs[ACK_BATCH][ACK_MAX];
+
+    for (;;) {
+        for (int i = 0; i < ACK_BATCH; i++) {
+            iovs[i] = (struct iovec){bufs[i], ACK_MAX};
+            msgs[i].msg_hdr = (struct msghdr){
+                .msg_name = &addrs[i], .msg_namelen = sizeof(addrs[i]),
+                .msg_iov = &iovs[i], .msg_iovlen = 1,
+            };
+        }
+
+        const int count = recvmmsg(server->socket, msgs, ACK_BATCH, MSG_DONTWAIT, 0);
+        if (count <= 0)
+            break;
+
+        for (int i = 0; i < count; i++) {
+            handlePacket(server, bufs[i], msgs[i].msg_len, &addrs[i]);
+        }
+
+        if (count < ACK_BATCH)
+            break;
+    }
+#else
+    uint8_t buf[16];
+    struct sockaddr_in addr;
+    socklen_t addrLen = sizeof(addr);
+
+    ssize_t len;
+    while ((len = recvfrom(server->socket, buf, sizeof(buf), 0, (struct sockaddr*)&addr, &addrLen)) > 0) {
+        handlePacket(server, buf, (size_t)len, &addr);
+        addrLen = sizeof(addr);
+    }
+#endif
+}
+
+static void sendBatch(SpectatorServer_t* server, int count) {
+    int pos = 0, sent = 0;
+    while (pos < count) {
+#ifdef __linux__
+        const int result = sendmmsg(server->socket, &sendMsgs[pos], (unsigned int)(count - pos), MSG_DONTWAIT);
+        if (result > 0) {
+            for (int i = pos; i < pos + result; i++) {
+                server->bytesSent += sendMsgs[i].msg_len;
+            }
+            pos += result;
+            sent += result;
+            continue;
+        }
+#else
+        const ssize_t result = sendmsg(server->socket, &sendMsgs[pos], MSG_DONTWAIT);
+        if (result >= 0) {
+            server->bytesSent += (uint64_t)result;
+            pos++;
+            sent++;
+            continue;
+        }
+#endif
+        // a full socket buffer drops the rest of the tick, any other error only that viewer
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+            break;
+        pos++;
+    }
+
+    server->packetsSent += (uint64_t)sent;
+    server->packetsDropped += (uint64_t)(count - sent);
+}
+
+int spectatorServerOpen(SpectatorServer_t* server, uint16_t port) {
+    *server = (SpectatorServer_t){0};
+
+    server->socket = openSocket(port);
+    if (server->socket < 0)
+        return -1;
+
+    struct sockaddr_in addr;
+    socklen_t addrLen = sizeof(addr);
+    if (getsockname(server->socket, (struct sockaddr*)&addr, &addrLen) == 0)
+        server->port = ntohs(addr.sin_port);
+
+    // without randomness the cookies could be forged, don't serve at all
+    if (readRandom(server->cookieKeys, sizeof(server->cookieKeys))) {
+        close(server->socket);
+        server->socket = -1;
+        return -1;
+    }
+
+    // every viewer acks every tick, leave room for a burst from all of them
+    const int bufferSize = 4 * 1024 * 1024;
+    setsockopt(server->socket, SOL_SOCKET, SO_RCVBUF, &bufferSize, sizeof(bufferSize));
+    setsockopt(server->socket, SOL_SOCKET, SO_SNDBUF, &bufferSize, sizeof(bufferSize));
+
+    return 0;
+}
+
+void spectatorServerClose(SpectatorServer_t* server) {
+    close(server->socket);
+    free(server->viewerMap);
+    free(server->viewers);
+    *server = (SpectatorServer_t){0};
+    server->socket = -1;
+}
+
+void spectatorServerBroadcast(SpectatorServer_t* server, const PhysicsState_t* state) {
+    struct {
+        uint32_t baseline;
+        size_t len;
+        uint8_t data[SPECTATOR_MAX_PACKET];
+    } packets[SPECTATOR_MAX_BASELINES + 1];
+    int packetCount = 0;
+
+    drainAcks(server);
+    evictViewers(server);
+
+    if (server->tick && server->tick % SPECTATOR_KEY_ROTATION == 0)
+        rotateCookieKey(server);
+
+    const uint32_t tick = ++server->tick;
+    Snapshot_t* snap = &server->history[tick % SPECTATOR_HISTORY];
+    quantizeSnapshot(state, tick, snap);
+
+    // packets[0] is the full snapshot, the fallback for everything else, only encoded when needed
+    packets[packetCount].baseline = 0;
+    packets[packetCount].len = 0;
+    packetCount++;
+
+    int batch = 0;
+    for (size_t i = 0; i < server->viewerCount; i++) {
+        SpectatorViewer_t* viewer = &server->viewers[i];
+
+        // most viewers ack the same tick, so each distinct baseline is only encoded once
+        int packet = 0;
+        const Snapshot_t* baseline = tick - viewer->ackTick < SPECTATOR_HISTORY ? findSnapshot(server->history, viewer->ackTick) : 0;
+        if (!baseline && viewer->ackTick)
+            server->staleAcks++;
+        if (baseline) {
+            for (packet = 1; packet < packetCount && packets[packet].baseline != baseline->tick; packet++);
+
+            if (packet == packetCount) {
+                if (packetCount <= SPECTATOR_MAX_BASELINES) {
+                    packets[packet].baseline = baseline->tick;
+                    packets[packet].len = encodeSnapshot(snap, baseline, packets[packet].data);
+                    packetCount++;
+                    server->packetsEncoded++;
+                } else {
+                    packet = 0;
+                    server->baselineOverflows++;
+                }
+            }
+        }
+
+        if (!packets[packet].len) {
+            packets[packet].len = encodeSnapshot(snap, 0, packets[packet].data);
+            server->packetsEncoded++;
+        }
+
+        sendIovs[batch] = (struct iovec){packets[packet].data, packets[packet].len};
+        *sendHeader(batch) = (struct msghdr){
+            .msg_name = &viewer->addr, .msg_namelen = sizeof(viewer->addr),
+            .msg_iov = &sendIovs[batch], .msg_iovlen = 1,
+        };
+
+        if (++batch == SPECTATOR_SEND_BATCH) {
+            sendBatch(server, batch);
+            batch = 0;
+        }
+    }
+
+    if (batch)
+        sendBatch(server, batch);
+}
+
+static void sendToServer(SpectatorClient_t* client, const uint8_t* packet, size_t len) {
+    sendto(client->socket, packet, len, 0, (struct sockaddr*)&client->server, sizeof(client->server));
+}
+
+static int simulateLoss(SpectatorClient_t* client) {
+    if (!client->simulatedLoss)
+        return 0;
+
+    client->lossRandom = client->lossRandom * 1664525u + 1013904223u;
+    return (client->lossRandom >> 16) % 100 < client->simulatedLoss;
+}
+
+static void sendJoin(SpectatorClient_t* client) {
+    const uint8_t packet[HANDSHAKE_PACKET_SIZE] = {PACKET_JOIN};
+    sendToServer(client, packet, sizeof(packet));
+}
+
+static void sendAck(SpectatorClient_t* client, uint32_t tick) {
+    if (simulateLoss(client))
+        return;
+
+    uint8_t packet[16];
+    size_t len = 0;
+
+    packet[len++] = PACKET_ACK;
+    len += writeU32(&packet[len], client->cookie);
+    len += writeVarint(&packet[len], tick);
+
+    sendToServer(client, packet, len);
+}
+
+static void sendLeave(SpectatorClient_t* client) {
+    uint8_t packet[8];
+    size_t len = 0;
+
+    packet[len++] = PACKET_LEAVE;
+    len += writeU32(&packet[len], client->cookie);
+
+    sendToServer(client, packet, len);
+}
+
+int spectatorClientOpen(SpectatorClient_t* client, const char* host, uint16_t port) {
+    *client = (SpectatorClient_t){0};
+
+    client->server.sin_family = AF_INET;
+    client->server.sin_port = htons(port);
+    if (inet_pton(AF_INET, host, &client->server.sin_addr) != 1)
+        return -1;
+
+    client->socket = openSocket(0);
+    if (client->socket < 0)
+        return -1;
+
+    sendJoin(client);
+    return 0;
+}
+
+void spectatorClientClose(SpectatorClient_t* client) {
+    if (client->joined)
+        sendLeave(client);
+
+    close(client->socket);
+    *client = (SpectatorClient_t){0};
+    client->socket = -1;
+}
+
+int spectatorClientPoll(SpectatorClient_t* client) {
+    uint8_t packet[SPECTATOR_MAX_PACKET];
+    struct sockaddr_in addr;
+    socklen_t addrLen = sizeof(addr);
+
+    int decoded = 0, challenged = 0;
+
+    ssize_t len;
+    while ((len = recvfrom(client->socket, packet, sizeof(packet), MSG_DONTWAIT, (struct sockaddr*)&addr, &addrLen)) > 0) {
+        addrLen = sizeof(addr);
+        if (simulateLoss(client))
+            continue;
+
+        client->bytesReceived += (uint64_t)len;
+        client->packetsReceived++;
+
+        if (!sameAddr(&addr, &client->server)) {
+            client->packetsRejected++;
+            continue;
+        }
+
+        size_t pos = 1;
+        if (packet[0] == PACKET_CHALLENGE && !readU32(packet, (size_t)len, &pos, &client->cookie)) {
+            client->joined = 1;
+            challenged = 1;
+            continue;
+        }
+
+        Snapshot_t snap;
+        if (!client->joined || decodeSnapshot(packet, (size_t)len, client->history, &snap)) {
+            client->packetsRejected++;
+            continue;
+        }
+
+        // late packets older than the ring are useless for interpolation
+        if (client->latestTick >= SPECTATOR_HISTORY && snap.tick <= client->latestTick - SPECTATOR_HISTORY) {
+            client->packetsLate++;
+            continue;
+        }
+
+        client->history[snap.tick % SPECTATOR_HISTORY] = snap;
+        if (snap.tick > client->latestTick)
+            client->latestTick = snap.tick;
+        decoded++;
+    }
+
+    // one ack per poll, and keep retrying the handshake until the first snapshot arrives
+    if (!client->joined)
+        sendJoin(client);
+    else if (decoded || challenged || !client->latestTick)
+        sendAck(client, client->latestTick);
+
+    return decoded;
+}
+
+int spectatorClientInterpolate(const SpectatorClient_t* client, float tick, PhysicsState_t* out) {
+    if (!client->latestTick)
+        return 0;
+
+    if (tick > (float)client->latestTick)
+        tick = (float)client->latestTick;
+
+    // newest snapshot at or before tick, and the oldest one after it
+    const Snapshot_t* from = 0;
+    const Snapshot_t* to = 0;
+
+    const uint32_t start = tick < 1.0f ? 1 : (uint32_t)tick;
+    for (uint32_t t = start; t > 0 && start - t < SPECTATOR_HISTORY && !from; t--) {
+        from = findSnapshot(client->history, t);
+    }
+    for (uint32_t t = start + 1; t <= client->latestTick && t - start < SPECTATOR_HISTORY && !to; t++) {
+        to = findSnapshot(client->history, t);
+    }
+
+    if (!from && !to)
+        return 0;
+    if (!from)
+        from = to;
+    if (!to)
+        to = from;
+
+    float alpha = to->tick != from->tick ? (tick - (float)from->tick) / (float)(to->tick - from->tick) : 0.0f;
+    if (alpha < 0.0f) alpha = 0.0f;
+    if (alpha > 1.0f) alpha = 1.0f;
+
+    float fields[SNAPSHOT_FIELD_COUNT];
+    for (int i = 0; i < SNAPSHOT_FIELD_COUNT; i++) {
+        const float a = (float)from->fields[i];
+        const float b = (float)to->fields[i];
+        fields[i] = (a + (b - a) * alpha) / fieldScales[i];
+    }
+
+    // the ball is reset to the center after a point, don't sweep it across the arena
+    if (fabsf((float)(to->fields[SNAPSHOT_BALL_X] - from->fields[SNAPSHOT_BALL_X])) > 0.5f * fieldScales[SNAPSHOT_BALL_X]) {
+        const Snapshot_t* nearest = alpha < 0.5f ? from : to;
+        for (int i = 0; i < SNAPSHOT_FIELD_COUNT; i++) {
+            fields[i] = (float)nearest->fields[i] / fieldScales[i];
+        }
+    }
+
+    out->ball.offset[0]     = fields[SNAPSHOT_BALL_X];
+    out->ball.offset[1]     = fields[SNAPSHOT_BALL_Y];
+    out->ballDX             = fields[SNAPSHOT_BALL_DX];
+    out->ballDY             = fields[SNAPSHOT_BALL_DY];
+    out->player1.offset[1]  = fields[SNAPSHOT_PLAYER1_Y];
+    out->player2.offset[1]  = fields[SNAPSHOT_PLAYER2_Y];
+
+    return 1;
+}
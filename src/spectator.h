@@ -0,0 +1,126 @@
+
+#ifndef __spectator_h__
+#define __spectator_h__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <netinet/in.h>
+
+#include "physics.h"
+
+/* snapshots kept by both ends, a baseline older than this is never used */
+#define SPECTATOR_HISTORY 64
+
+/* largest encoded snapshot packet */
+#define SPECTATOR_MAX_PACKET 64
+
+/* viewers sent to per sendmmsg() call */
+#define SPECTATOR_SEND_BATCH 1024
+
+/* distinct baselines encoded per tick, viewers past this get a full snapshot */
+#define SPECTATOR_MAX_BASELINES 8
+
+/* ticks without an ack before a viewer is dropped, 5 seconds at 120 Hz */
+#define SPECTATOR_VIEWER_TIMEOUT 600
+
+/* ticks between cookie key changes, 1 minute at 120 Hz, cookies of the previous key stay valid */
+#define SPECTATOR_KEY_ROTATION 7200
+
+enum {
+    SNAPSHOT_BALL_X,
+    SNAPSHOT_BALL_Y,
+    SNAPSHOT_BALL_DX,
+    SNAPSHOT_BALL_DY,
+    SNAPSHOT_PLAYER1_Y,
+    SNAPSHOT_PLAYER2_Y,
+    SNAPSHOT_FIELD_COUNT,
+};
+
+/* quantized state of one tick, tick 0 is never sent and means "no snapshot" */
+typedef struct Snapshot_s {
+    uint32_t tick;
+    int16_t fields[SNAPSHOT_FIELD_COUNT];
+} Snapshot_t;
+
+typedef struct SpectatorViewer_s {
+    struct sockaddr_in addr;
+    uint32_t ackTick;
+
+    /* server tick of the last packet from the viewer */
+    uint32_t heardTick;
+    uint8_t left;
+} SpectatorViewer_t;
+
+typedef struct SpectatorServer_s {
+    int socket;
+    uint16_t port;
+
+    SpectatorViewer_t* viewers;
+    size_t viewerCount, viewerCapacity;
+
+    /* open addressing map from address to viewers index + 1 */
+    uint32_t* viewerMap;
+    size_t viewerMapCapacity;
+
+    /* SipHash keys of the join cookies, current and previous, so only addresses that can receive become viewers */
+    uint64_t cookieKeys[2][2];
+
+    Snapshot_t history[SPECTATOR_HISTORY];
+    uint32_t tick;
+
+    /* totals since start */
+    uint64_t bytesSent, packetsSent, packetsDropped;
+    uint64_t packetsEncoded;
+    uint64_t viewersEvicted;
+
+    /* viewers sent a full snapshot because their ack left the history, or because of SPECTATOR_MAX_BASELINES */
+    uint64_t staleAcks, baselineOverflows;
+} SpectatorServer_t;
+
+typedef struct SpectatorClient_s {
+    int socket;
+    struct sockaddr_in server;
+
+    /* cookie from the server challenge, sent with every ack */
+    uint32_t cookie;
+    uint8_t joined;
+
+    Snapshot_t history[SPECTATOR_HISTORY];
+    uint32_t latestTick;
+
+    /* percent of received packets and sent acks thrown away, to test recovery from loss, 0 in normal use */
+    uint8_t simulatedLoss;
+    uint32_t lossRandom;
+
+    uint64_t bytesReceived, packetsReceived, packetsRejected;
+    /* snapshots too old for the history, they would overwrite a newer one */
+    uint64_t packetsLate;
+} SpectatorClient_t;
+
+void quantizeSnapshot(const PhysicsState_t* state, uint32_t tick, Snapshot_t* out);
+
+/* encodes snap against baseline (0 for a full snapshot), returns the packet length */
+size_t encodeSnapshot(const Snapshot_t* snap, const Snapshot_t* baseline, uint8_t* out);
+
+/* returns 0 on success, baseline is looked up in history by the tick in the packet */
+int decodeSnapshot(const uint8_t* packet, size_t len, const Snapshot_t* history, Snapshot_t* out);
+
+/* port 0 binds any free port, the bound one is stored in server->port */
+int spectatorServerOpen(SpectatorServer_t* server, uint16_t port);
+void spectatorServerClose(SpectatorServer_t* server);
+
+/* drains joins and acks, drops silent viewers, then sends the next tick to every viewer on the calling thread */
+void spectatorServerBroadcast(SpectatorServer_t* server, const PhysicsState_t* state);
+
+int spectatorClientOpen(SpectatorClient_t* client, const char* host, uint16_t port);
+/* tells the server the viewer left and closes the socket */
+void spectatorClientClose(SpectatorClient_t* client);
+
+/* joins, then receives and acknowledges all pending snapshots, returns the number decoded */
+int spectatorClientPoll(SpectatorClient_t* client);
+
+/* fills the streamed fields of out at a fractional tick, returns 0 if there is no data yet */
+int spectatorClientInterpolate(const SpectatorClient_t* client, float tick, PhysicsState_t* out);
+
+#endif
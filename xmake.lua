@@ -1,4 +1,3 @@
-
 add_rules("mode.debug", "mode.release")
 
 set_targetdir("bin")
@@ -9,8 +8,29 @@ set_warnings("allextra", "error")
 
 add_requires("glfw", "glad")
 
+option("fixed-physics")
+    set_default(false)
+    set_showmenu(true)
+    set_description("Use the deterministic Q16.16 fixed-point physics")
+    add_defines("PONG_FIXED_PHYSICS")
+option_end()
+
 target("pong")
     set_kind("binary")
-    add_files("src/**.c")
+    add_files("src/**.c|spectator.c")
+    add_options("fixed-physics")
 
     add_packages("glfw", "glad")
+
+target("physics-bench")
+    set_kind("binary")
+    set_default(false)
+    add_files("bench/physics.c", "src/physics.c")
+    add_includedirs("src")
+
+target("spectator-bench")
+    set_kind("binary")
+    set_default(false)
+    add_files("bench/spectator.c", "src/spectator.c", "src/physics.c")
+    add_includedirs("src")
+    add_syslinks("m")